@@ -3,11 +3,30 @@
 
 #include <mfem.hpp>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 class ND_NitscheIntegrator : public mfem::BilinearFormIntegrator
 {
 protected:
     double factor_, theta_, Cw_;
 
+    // Scratch for the packed upper triangle in the symmetric path.
+    mfem::DenseSymmetricMatrix elmat_sym_;
+
+    // Per quadrature point scratch: shapes, curl-shapes, n x shape and
+    // n x curl-shape (ndof x 3) and the unit normal.
+    mfem::DenseMatrix shape_, curl_shape_, n_x_shape_, n_x_curl_shape_;
+    mfem::Vector normal_;
+
+    /** Fills the scratch matrices at @a ip_face and returns the quadrature
+        weight (including factor and face area); sets the penalty Cw/h. */
+    double CalcFaceShapes(const mfem::FiniteElement &el1,
+                          mfem::FaceElementTransformations &Trans,
+                          const mfem::IntegrationPoint &ip_face,
+                          double &penalty);
+
 public:
     ND_NitscheIntegrator(double theta, double Cw, double factor = 1.) : factor_(factor), theta_(theta), Cw_(Cw){};
 
@@ -20,6 +39,92 @@ public:
                             mfem::FaceElementTransformations &Trans, 
                             mfem::DenseMatrix &elmat);
 
+    /// The form is symmetric for theta = 1 (SIPG-style configuration).
+    bool IsSymmetric() const { return theta_ == 1.; }
+
+    double GetTheta() const { return theta_; }
+    double GetCw() const { return Cw_; }
+    double GetFactor() const { return factor_; }
+
+    /** Assembles only the upper triangle of the face matrix and stores it in
+        packed form. Requires IsSymmetric(). AssembleFaceMatrix() uses this and
+        expands the result, since BilinearForm expects a full DenseMatrix: on
+        that path the packing is only an intermediate and saves flops, not
+        storage. Custom assembly loops can keep the packed matrices. */
+    void AssembleSymmetricFaceMatrix(const mfem::FiniteElement &el1,
+                                     mfem::FaceElementTransformations &Trans,
+                                     mfem::DenseSymmetricMatrix &elmat);
+
+};
+
+/** Assembles the ND_NitscheIntegrator face matrices for batches of boundary
+    faces that share face geometry, element type and order. Quadrature data is
+    stored structure-of-arrays with the face index innermost, so the cross
+    products and accumulations run over the faces of a batch with unit stride
+    (marked `omp simd`, enabled with -fopenmp-simd) rather than over the
+    (small, at low order) dof loops of a single face. Shapes are still
+    tabulated face by face; only the contraction is batched. */
+class ND_NitscheFaceBatch
+{
+public:
+   /// Number of faces processed together (SIMD lanes).
+   static constexpr int lanes = 8;
+
+protected:
+   ND_NitscheIntegrator nitsche_;
+
+   // Structure-of-arrays buffers, faces innermost.
+   std::vector<double> wa_, pen_, normal_, shape_, curl_shape_;
+   std::vector<double> n_x_shape_, n_x_curl_shape_, acc_;
+
+   void GetAdjacentElements(mfem::FiniteElementSpace &fes,
+                            const mfem::Array<int> &bdr_faces,
+                            mfem::Array<int> &elems);
+
+   /// Verifies that the faces form one group and returns its element.
+   const mfem::FiniteElement &CheckGroup(mfem::FiniteElementSpace &fes,
+                                         const mfem::Array<int> &bdr_faces,
+                                         const mfem::Array<int> &elems);
+
+   /// As AssembleFaceMatrices(), with the adjacent elements @a elems known.
+   void AssembleGroup(mfem::FiniteElementSpace &fes,
+                      const mfem::Array<int> &bdr_faces,
+                      const mfem::Array<int> &elems,
+                      mfem::DenseTensor &elmats);
+
+   /// As AssembleSymmetricFaceMatrices(), with the adjacent elements known.
+   void AssembleSymmetricGroup(mfem::FiniteElementSpace &fes,
+                               const mfem::Array<int> &bdr_faces,
+                               const mfem::Array<int> &elems,
+                               std::vector<mfem::DenseSymmetricMatrix> &elmats);
+
+   /// Accumulates the face matrices of up to @a lanes faces into acc_.
+   void AssembleBatch(mfem::FiniteElementSpace &fes,
+                      const mfem::FiniteElement &el1,
+                      const mfem::IntegrationRule &ir,
+                      const int *bdr_faces, int nfaces);
+
+public:
+   ND_NitscheFaceBatch(double theta, double Cw, double factor = 1.)
+      : nitsche_(theta, Cw, factor) { }
+
+   /** Computes elmats(:,:,i) for the boundary elements @a bdr_faces[i], which
+       must all have the same face geometry, element type and order, and lie
+       on true boundary faces of a conforming mesh. */
+   void AssembleFaceMatrices(mfem::FiniteElementSpace &fes,
+                             const mfem::Array<int> &bdr_faces,
+                             mfem::DenseTensor &elmats);
+
+   /** As AssembleFaceMatrices(), but keeps only the upper triangle of each
+       face matrix in packed form. Requires theta = 1. */
+   void AssembleSymmetricFaceMatrices(mfem::FiniteElementSpace &fes,
+                                      const mfem::Array<int> &bdr_faces,
+                                      std::vector<mfem::DenseSymmetricMatrix> &elmats);
+
+   /** Groups all boundary faces of @a fes and adds their face matrices to
+       @a A, in the same way as BilinearForm::AddBdrFaceIntegrator. For
+       theta = 1 the face matrices stay packed until they are scattered. */
+   void Assemble(mfem::FiniteElementSpace &fes, mfem::SparseMatrix &A);
 };
 
 class ND_NitscheLFIntegrator : public mfem::LinearFormIntegrator
@@ -43,4 +148,102 @@ public:
                                        mfem::Vector &elvect);
 };
 
+/** Nitsche right-hand side for time-separable boundary data
+    g(x,t) = sum_i a_i(t) f_i(x). Each spatial mode f_i is swept over the
+    boundary once in Assemble(); afterwards the right-hand side at any time t
+    is a linear combination of the cached mode vectors. */
+class ND_NitscheSeparableLF
+{
+protected:
+   mfem::FiniteElementSpace &fes_;
+   double factor_, theta_, Cw_;
+   std::vector<mfem::VectorCoefficient *> modes_;
+   std::vector<std::function<double(double)>> amplitudes_;
+   std::vector<mfem::Vector> mode_vectors_;
+
+public:
+   ND_NitscheSeparableLF(mfem::FiniteElementSpace &fes, double theta, double Cw,
+                         double factor = 1.)
+      : fes_(fes), factor_(factor), theta_(theta), Cw_(Cw) { }
+
+   /// Adds the mode a(t) f(x). @a f must outlive Assemble().
+   void AddMode(mfem::VectorCoefficient &f, std::function<double(double)> a);
+
+   /// Assembles the cached vector of every mode with ND_NitscheLFIntegrator.
+   void Assemble();
+
+   /// Computes b = sum_i a_i(t) b_i without a boundary sweep.
+   void Eval(double t, mfem::Vector &b) const;
+
+   int GetNumModes() const { return static_cast<int>(modes_.size()); }
+   const mfem::Vector &GetModeVector(int i) const { return mode_vectors_[i]; }
+};
+
+/** Hiptmair hybrid smoother for H(curl): a forward Gauss-Seidel sweep on the
+    ND matrix A, a symmetric Gauss-Seidel sweep on the H1 potential matrix
+    G^T A G mapped in through the discrete gradient G, and a backward
+    Gauss-Seidel sweep on A. Point Gauss-Seidel on A alone does not smooth the
+    gradient near-kernel of curl-curl. The sweep is symmetric, so
+    MultTranspose() equals Mult(). */
+class ND_HiptmairSmoother : public mfem::Solver
+{
+protected:
+   const mfem::SparseMatrix &A_, &G_;
+   std::unique_ptr<mfem::SparseMatrix> A_G_;
+   mutable mfem::Vector r_, r_G_, x_G_;
+
+public:
+   /// @a A and @a G must outlive the smoother.
+   ND_HiptmairSmoother(const mfem::SparseMatrix &A, const mfem::SparseMatrix &G);
+
+   virtual void SetOperator(const mfem::Operator &op);
+
+   virtual void Mult(const mfem::Vector &b, mfem::Vector &x) const;
+   virtual void MultTranspose(const mfem::Vector &b, mfem::Vector &x) const
+   { Mult(b, x); }
+};
+
+/** Geometric multigrid over a FiniteElementSpaceHierarchy (uniform refinement
+    or p-coarsening) for alpha curl-curl + beta mass + Nitsche boundary terms.
+    All levels share a single set of integrators and the hierarchy's meshes,
+    so no level is built from scratch. Nitsche imposes the boundary condition
+    weakly, hence there are no essential dofs on any level. Fine levels are
+    smoothed with ND_HiptmairSmoother, using an H1 space of the same order on
+    the level's mesh; without @a beta the potential matrix is singular and
+    plain Gauss-Seidel is used instead. The coarsest level is solved directly
+    with UMFPack when available, otherwise iteratively to a tight tolerance. */
+class ND_NitscheMultigrid : public mfem::GeometricMultigrid
+{
+protected:
+   ND_NitscheIntegrator nitsche_;
+   std::unique_ptr<mfem::CurlCurlIntegrator> curlcurl_;
+   std::unique_ptr<mfem::VectorFEMassIntegrator> mass_;
+   std::unique_ptr<mfem::Solver> coarse_prec_;
+
+   // H1 potential spaces and discrete gradients of the fine levels.
+   std::vector<std::unique_ptr<mfem::FiniteElementCollection>> h1_fecs_;
+   std::vector<std::unique_ptr<mfem::FiniteElementSpace>> h1_spaces_;
+   std::vector<std::unique_ptr<mfem::DiscreteLinearOperator>> gradients_;
+
+   /// All-zero essential boundary marker: Nitsche imposes the BC weakly.
+   static mfem::Array<int> NoEssentialBoundary(
+      const mfem::FiniteElementSpaceHierarchy &fespaces);
+
+   void ConstructBilinearForm(mfem::FiniteElementSpace &fespace);
+   const mfem::SparseMatrix &ConstructGradient(mfem::FiniteElementSpace &fespace);
+   void ConstructCoarseOperatorAndSolver(mfem::FiniteElementSpace &coarse_fespace);
+   void ConstructOperatorAndSmoother(mfem::FiniteElementSpace &fespace);
+
+public:
+   /** The coefficients @a alpha and @a beta are optional and must outlive the
+       multigrid object. */
+   ND_NitscheMultigrid(mfem::FiniteElementSpaceHierarchy &fespaces,
+                       double theta, double Cw,
+                       mfem::Coefficient *alpha = nullptr,
+                       mfem::Coefficient *beta = nullptr,
+                       double factor = 1.);
+
+   mfem::BilinearForm &GetFormAtLevel(int level) { return *bfs[level]; }
+};
+
 #endif
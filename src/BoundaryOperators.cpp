@@ -1,6 +1,10 @@
 #include "BoundaryOperators.h"
 #include "mfem.hpp"
 
+#include <algorithm>
+#include <map>
+#include <tuple>
+
 
 
 void ND_NitscheIntegrator::AssembleElementMatrix(const mfem::FiniteElement &el, mfem::ElementTransformation &Trans,
@@ -9,6 +13,80 @@ void ND_NitscheIntegrator::AssembleElementMatrix(const mfem::FiniteElement &el,
    MFEM_ABORT("ND_NitscheIntegrator::AssembleElementMatrix(): method is not implemented for this class");
 }
 
+namespace
+{
+
+/// Face quadrature shared by the Nitsche face kernels.
+const mfem::IntegrationRule &NitscheFaceRule(int face_geom,
+                                             const mfem::FiniteElement &el)
+{
+   return mfem::IntRules.Get(static_cast<mfem::Geometry::Type>(face_geom),
+                             2*el.GetOrder()+1);
+}
+
+/// Component @a d of n x a, for 3-vectors stored with strides @a ns and @a as.
+inline double NormalCross(const double *n, int ns, const double *a, int as, int d)
+{
+   const int d1 = (d+1)%3, d2 = (d+2)%3;
+   return n[d1*ns]*a[d2*as] - n[d2*ns]*a[d1*as];
+}
+
+/** Nitsche integrand for trial function u and test function v, all 3-vectors
+    stored with stride @a s:
+    (n x curl u).v + theta u.(n x curl v) + penalty (n x u).(n x v). */
+inline double NitscheIntegrand(double theta, double penalty, int s,
+                               const double *u, const double *v,
+                               const double *n_x_curl_u, const double *n_x_curl_v,
+                               const double *n_x_u, const double *n_x_v)
+{
+   double val = 0.;
+   for (int d = 0; d < 3; d++)
+   {
+      val += n_x_curl_u[d*s]*v[d*s] + theta*u[d*s]*n_x_curl_v[d*s]
+             + penalty*n_x_u[d*s]*n_x_v[d*s];
+   }
+   return val;
+}
+
+}
+
+double ND_NitscheIntegrator::CalcFaceShapes(const mfem::FiniteElement &el1,
+                                            mfem::FaceElementTransformations &Trans,
+                                            const mfem::IntegrationPoint &ip_face,
+                                            double &penalty)
+{
+   const int ndof = el1.GetDof();
+   normal_.SetSize(3);
+   shape_.SetSize(ndof, 3);
+   curl_shape_.SetSize(ndof, 3);
+   n_x_shape_.SetSize(ndof, 3);
+   n_x_curl_shape_.SetSize(ndof, 3);
+
+   // Sync face + element integration points. This ensures ip on the element
+   // matches the face point orientation (important for tangential fields).
+   Trans.SetAllIntPoints(&ip_face);
+
+   mfem::CalcOrtho(Trans.Face->Jacobian(), normal_);
+   double area = normal_.Norml2();
+   double h = sqrt(area);
+   normal_ *= 1./area;
+
+   el1.CalcVShape(*Trans.Elem1, shape_);
+   el1.CalcPhysCurlShape(*Trans.Elem1, curl_shape_);
+
+   // n x u and n x curl(u) only depend on a single dof, so compute them
+   // once per quadrature point instead of once per (l,k) pair.
+   for (int k = 0; k < ndof; k++)
+      for (int d = 0; d < 3; d++)
+      {
+         n_x_shape_(k,d) = NormalCross(normal_.GetData(), 1, &shape_(k,0), ndof, d);
+         n_x_curl_shape_(k,d) = NormalCross(normal_.GetData(), 1, &curl_shape_(k,0), ndof, d);
+      }
+
+   penalty = Cw_/h;
+   return factor_ * ip_face.weight * area;
+}
+
 void ND_NitscheIntegrator::AssembleFaceMatrix(
     const mfem::FiniteElement &el1, const mfem::FiniteElement &el2,
     mfem::FaceElementTransformations &Trans, mfem::DenseMatrix &elmat)
@@ -16,70 +94,362 @@ void ND_NitscheIntegrator::AssembleFaceMatrix(
    MFEM_ASSERT(Trans.Elem2No < 0,
                "support for interior faces is not implemented");
 
-   int dim = el1.GetDim();
-   mfem::Vector normal(dim);
+   const int ndof = el1.GetDof();
+   elmat.SetSize(ndof, ndof);
 
-   mfem::IntegrationPoint ip_face;
+   if (IsSymmetric())
+   {
+      // Assemble the upper triangle only and mirror it, so the global matrix
+      // is exactly symmetric.
+      AssembleSymmetricFaceMatrix(el1, Trans, elmat_sym_);
 
-   // Build a reasonable quadrature on the actual face geometry
-   const mfem::IntegrationRule *ir = IntRule;
-   ir = &mfem::IntRules.Get(static_cast<mfem::Geometry::Type>(Trans.FaceGeom),
-                            2*el1.GetOrder()+1);
+      for (int l = 0; l < ndof; l++)
+         for (int k = l; k < ndof; k++)
+         {
+            elmat.Elem(l,k) = elmat_sym_(l,k);
+            elmat.Elem(k,l) = elmat_sym_(l,k);
+         }
+      return;
+   }
+
+   const mfem::IntegrationRule &ir = NitscheFaceRule(Trans.FaceGeom, el1);
 
-   elmat.SetSize(el1.GetDof(), el1.GetDof());
    elmat = 0.;
-   auto weights = ir->GetWeights();
+   for (int i = 0; i < ir.GetNPoints(); ++i)
+   {
+      double penalty;
+      const double w = CalcFaceShapes(el1, Trans, ir.IntPoint(i), penalty);
 
-   for (int i = 0; i < ir->GetNPoints(); ++i)
+      for (int l = 0; l < ndof; l++)
+         for (int k = 0; k < ndof; k++)
+         {
+            elmat(l,k) += w * NitscheIntegrand(theta_, penalty, ndof,
+                                               &shape_(k,0), &shape_(l,0),
+                                               &n_x_curl_shape_(k,0), &n_x_curl_shape_(l,0),
+                                               &n_x_shape_(k,0), &n_x_shape_(l,0));
+         }
+   }
+}
+
+void ND_NitscheIntegrator::AssembleSymmetricFaceMatrix(
+    const mfem::FiniteElement &el1, mfem::FaceElementTransformations &Trans,
+    mfem::DenseSymmetricMatrix &elmat)
+{
+   MFEM_ASSERT(Trans.Elem2No < 0,
+               "support for interior faces is not implemented");
+   MFEM_VERIFY(IsSymmetric(),
+               "ND_NitscheIntegrator::AssembleSymmetricFaceMatrix(): requires theta = 1");
+
+   const int ndof = el1.GetDof();
+   const mfem::IntegrationRule &ir = NitscheFaceRule(Trans.FaceGeom, el1);
+
+   elmat.SetSize(ndof);
+   elmat = 0.;
+
+   for (int i = 0; i < ir.GetNPoints(); ++i)
    {
-      ip_face = ir->IntPoint(i);
+      double penalty;
+      const double w = CalcFaceShapes(el1, Trans, ir.IntPoint(i), penalty);
 
-      // Sync face + element integration points. This ensures ip on the element
-      // matches the face point orientation (important for tangential fields).
-      Trans.SetAllIntPoints(&ip_face);
-      const mfem::IntegrationPoint &ip_elem = Trans.Elem1->GetIntPoint();
+      for (int l = 0; l < ndof; l++)
+         for (int k = l; k < ndof; k++)
+         {
+            elmat(l,k) += w * NitscheIntegrand(theta_, penalty, ndof,
+                                               &shape_(k,0), &shape_(l,0),
+                                               &n_x_curl_shape_(k,0), &n_x_curl_shape_(l,0),
+                                               &n_x_shape_(k,0), &n_x_shape_(l,0));
+         }
+   }
+}
 
-      // Face normal atu this quadrature point
-      Trans.Face->SetIntPoint(&ip_face);
-      mfem::CalcOrtho(Trans.Face->Jacobian(), normal);
-      
-      double area = normal.Norml2();
-      double h = sqrt(area);
-      normal *= 1./area; //normalize n
+void ND_NitscheFaceBatch::GetAdjacentElements(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    mfem::Array<int> &elems)
+{
+   elems.SetSize(bdr_faces.Size());
+   for (int i = 0; i < bdr_faces.Size(); i++)
+   {
+      int info;
+      fes.GetMesh()->GetBdrElementAdjacentElement(bdr_faces[i], elems[i], info);
+   }
+}
 
-      mfem::DenseMatrix shape(el1.GetDof(), Trans.GetSpaceDim());
-      mfem::DenseMatrix curl_shape(el1.GetDof(), 3);
+const mfem::FiniteElement &ND_NitscheFaceBatch::CheckGroup(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    const mfem::Array<int> &elems)
+{
+   MFEM_VERIFY(bdr_faces.Size() > 0,
+               "ND_NitscheFaceBatch::AssembleFaceMatrices(): no faces given");
 
-      mfem::ElementTransformation *tr1 = Trans.Elem1;
-      //tr1->SetIntPoint(&ip_face);
-      el1.CalcVShape(*tr1, shape);
-      el1.CalcPhysCurlShape(*tr1, curl_shape);
+   mfem::Mesh *mesh = fes.GetMesh();
+   const int face_geom = mesh->GetBdrElementGeometry(bdr_faces[0]);
+   const mfem::FiniteElement &el1 = *fes.GetFE(elems[0]);
 
-      mfem::Vector temp_out(3);
-      Trans.Transform(ip_face,temp_out);
+   for (int i = 1; i < bdr_faces.Size(); i++)
+   {
+      const mfem::FiniteElement &el = *fes.GetFE(elems[i]);
+      MFEM_VERIFY(mesh->GetBdrElementGeometry(bdr_faces[i]) == face_geom &&
+                  el.GetGeomType() == el1.GetGeomType() &&
+                  el.GetOrder() == el1.GetOrder(),
+                  "ND_NitscheFaceBatch::AssembleFaceMatrices(): all faces must "
+                  "share face geometry, element geometry and order");
+   }
+   return el1;
+}
+
+void ND_NitscheFaceBatch::AssembleFaceMatrices(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    mfem::DenseTensor &elmats)
+{
+   mfem::Array<int> elems;
+   GetAdjacentElements(fes, bdr_faces, elems);
+   AssembleGroup(fes, bdr_faces, elems, elmats);
+}
+
+void ND_NitscheFaceBatch::AssembleSymmetricFaceMatrices(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    std::vector<mfem::DenseSymmetricMatrix> &elmats)
+{
+   mfem::Array<int> elems;
+   GetAdjacentElements(fes, bdr_faces, elems);
+   AssembleSymmetricGroup(fes, bdr_faces, elems, elmats);
+}
+
+void ND_NitscheFaceBatch::AssembleGroup(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    const mfem::Array<int> &elems, mfem::DenseTensor &elmats)
+{
+   const mfem::FiniteElement &el1 = CheckGroup(fes, bdr_faces, elems);
+   const mfem::IntegrationRule &ir =
+      NitscheFaceRule(fes.GetMesh()->GetBdrElementGeometry(bdr_faces[0]), el1);
+   const int ndof = el1.GetDof();
+   const bool symmetric = nitsche_.IsSymmetric();
+
+   elmats.SetSize(ndof, ndof, bdr_faces.Size());
+
+   for (int offset = 0; offset < bdr_faces.Size(); offset += lanes)
+   {
+      const int nfaces = std::min(lanes, bdr_faces.Size() - offset);
+      AssembleBatch(fes, el1, ir, bdr_faces.GetData() + offset, nfaces);
+
+      // Scatter the active lanes back to one matrix per face.
+      for (int f = 0; f < nfaces; f++)
+      {
+         mfem::DenseMatrix &elmat = elmats(offset + f);
+         for (int l = 0; l < ndof; l++)
+            for (int k = (symmetric ? l : 0); k < ndof; k++)
+            {
+               elmat(l,k) = acc_[(l*ndof + k)*lanes + f];
+               if (symmetric) { elmat(k,l) = elmat(l,k); }
+            }
+      }
+   }
+}
+
+void ND_NitscheFaceBatch::AssembleSymmetricGroup(
+    mfem::FiniteElementSpace &fes, const mfem::Array<int> &bdr_faces,
+    const mfem::Array<int> &elems, std::vector<mfem::DenseSymmetricMatrix> &elmats)
+{
+   MFEM_VERIFY(nitsche_.IsSymmetric(),
+               "ND_NitscheFaceBatch::AssembleSymmetricFaceMatrices(): requires theta = 1");
+
+   const mfem::FiniteElement &el1 = CheckGroup(fes, bdr_faces, elems);
+   const mfem::IntegrationRule &ir =
+      NitscheFaceRule(fes.GetMesh()->GetBdrElementGeometry(bdr_faces[0]), el1);
+   const int ndof = el1.GetDof();
+
+   // Resize from empty, so no matrix is ever copied or moved.
+   elmats.clear();
+   elmats.resize(bdr_faces.Size());
+
+   for (int offset = 0; offset < bdr_faces.Size(); offset += lanes)
+   {
+      const int nfaces = std::min(lanes, bdr_faces.Size() - offset);
+      AssembleBatch(fes, el1, ir, bdr_faces.GetData() + offset, nfaces);
+
+      // Only the upper triangle was accumulated; store it packed.
+      for (int f = 0; f < nfaces; f++)
+      {
+         mfem::DenseSymmetricMatrix &elmat = elmats[offset + f];
+         elmat.SetSize(ndof);
+         for (int l = 0; l < ndof; l++)
+            for (int k = l; k < ndof; k++)
+            {
+               elmat(l,k) = acc_[(l*ndof + k)*lanes + f];
+            }
+      }
+   }
+}
+
+void ND_NitscheFaceBatch::AssembleBatch(
+    mfem::FiniteElementSpace &fes, const mfem::FiniteElement &el1,
+    const mfem::IntegrationRule &ir, const int *bdr_faces, int nfaces)
+{
+   constexpr int L = lanes;
+   mfem::Mesh *mesh = fes.GetMesh();
+
+   const int ndof = el1.GetDof();
+   const int nq = ir.GetNPoints();
+   const bool symmetric = nitsche_.IsSymmetric();
+   const double theta = nitsche_.GetTheta();
+
+   // Unused lanes of a partial batch keep zero weight and contribute nothing.
+   wa_.assign(nq*L, 0.);
+   pen_.assign(nq*L, 0.);
+   normal_.assign(nq*3*L, 0.);
+   shape_.assign(nq*ndof*3*L, 0.);
+   curl_shape_.assign(nq*ndof*3*L, 0.);
+   n_x_shape_.resize(ndof*3*L);
+   n_x_curl_shape_.resize(ndof*3*L);
+   acc_.assign(ndof*ndof*L, 0.);
+
+   // Gather: tabulate every face and transpose into the face-innermost layout.
+   // This is the only place the face transformation is built.
+   mfem::Vector normal(3);
+   mfem::DenseMatrix shape(ndof, 3), curl_shape(ndof, 3);
+   for (int f = 0; f < nfaces; f++)
+   {
+      mfem::FaceElementTransformations *Trans =
+         mesh->GetBdrFaceTransformations(bdr_faces[f]);
+      MFEM_VERIFY(Trans != nullptr,
+                  "ND_NitscheFaceBatch: boundary element " << bdr_faces[f]
+                  << " lies on an interior or nonconforming face");
+      for (int q = 0; q < nq; q++)
+      {
+         const mfem::IntegrationPoint &ip_face = ir.IntPoint(q);
+         Trans->SetAllIntPoints(&ip_face);
+
+         mfem::CalcOrtho(Trans->Face->Jacobian(), normal);
+         double area = normal.Norml2();
+         double h = sqrt(area);
 
-      for (int l = 0; l < el1.GetDof(); l++)
-         for (int k = 0; k < el1.GetDof(); k++)
+         el1.CalcVShape(*Trans->Elem1, shape);
+         el1.CalcPhysCurlShape(*Trans->Elem1, curl_shape);
+
+         wa_[q*L + f] = nitsche_.GetFactor() * ip_face.weight * area;
+         pen_[q*L + f] = nitsche_.GetCw()/h;
+         for (int d = 0; d < 3; d++)
+         {
+            normal_[(q*3 + d)*L + f] = normal(d)/area;
+         }
+         for (int k = 0; k < ndof; k++)
+            for (int d = 0; d < 3; d++)
+            {
+               shape_[((q*ndof + k)*3 + d)*L + f] = shape(k,d);
+               curl_shape_[((q*ndof + k)*3 + d)*L + f] = curl_shape(k,d);
+            }
+      }
+   }
+
+   // Compute: the innermost loops run over the L faces of the batch, with
+   // unit stride in every array.
+   for (int q = 0; q < nq; q++)
+   {
+      const double *wa = &wa_[q*L];
+      const double *pen = &pen_[q*L];
+      const double *n = &normal_[q*3*L];
+      const double *shp = &shape_[q*ndof*3*L];
+      const double *crl = &curl_shape_[q*ndof*3*L];
+      double *nxs = n_x_shape_.data();
+      double *nxc = n_x_curl_shape_.data();
+
+      for (int k = 0; k < ndof; k++)
+         for (int d = 0; d < 3; d++)
          {
-            mfem::Vector u(dim), v(dim);
-            shape.GetRow(k, u);
-            shape.GetRow(l, v);
-	    
-            mfem::Vector curl_u(dim), curl_v(dim);
-            curl_shape.GetRow(k, curl_u);
-            curl_shape.GetRow(l, curl_v);
+            #pragma omp simd
+            for (int f = 0; f < L; f++)
+            {
+               nxs[(k*3 + d)*L + f] = NormalCross(n + f, L, shp + k*3*L + f, L, d);
+               nxc[(k*3 + d)*L + f] = NormalCross(n + f, L, crl + k*3*L + f, L, d);
+            }
+         }
+
+      for (int l = 0; l < ndof; l++)
+         for (int k = (symmetric ? l : 0); k < ndof; k++)
+         {
+            double *acc = &acc_[(l*ndof + k)*L];
+            #pragma omp simd
+            for (int f = 0; f < L; f++)
+            {
+               acc[f] += wa[f] * NitscheIntegrand(theta, pen[f], L,
+                                                  shp + k*3*L + f, shp + l*3*L + f,
+                                                  nxc + k*3*L + f, nxc + l*3*L + f,
+                                                  nxs + k*3*L + f, nxs + l*3*L + f);
+            }
+         }
+   }
+}
+
+void ND_NitscheFaceBatch::Assemble(mfem::FiniteElementSpace &fes,
+                                   mfem::SparseMatrix &A)
+{
+   mfem::Mesh *mesh = fes.GetMesh();
+
+   // Group the boundary faces by face geometry, element geometry and order,
+   // recording the adjacent element so the scatter needs no transformation.
+   struct FaceGroup { mfem::Array<int> bdr_faces, elems; };
+   std::map<std::tuple<int, int, int>, FaceGroup> groups;
+   for (int i = 0; i < fes.GetNBE(); i++)
+   {
+      // Boundary elements on interior faces are skipped, as in BilinearForm.
+      if (mesh->FaceIsInterior(mesh->GetBdrElementFaceIndex(i))) { continue; }
+
+      int elem, info;
+      mesh->GetBdrElementAdjacentElement(i, elem, info);
+      const mfem::FiniteElement *el1 = fes.GetFE(elem);
+
+      FaceGroup &group =
+         groups[std::make_tuple(static_cast<int>(mesh->GetBdrElementGeometry(i)),
+                                static_cast<int>(el1->GetGeomType()),
+                                el1->GetOrder())];
+      group.bdr_faces.Append(i);
+      group.elems.Append(elem);
+   }
+
+   mfem::Array<int> vdofs;
+
+   if (!nitsche_.IsSymmetric())
+   {
+      mfem::DenseTensor elmats;
+      for (auto &entry : groups)
+      {
+         const FaceGroup &group = entry.second;
+         AssembleGroup(fes, group.bdr_faces, group.elems, elmats);
 
-            mfem::Vector n_x_curl_u(dim), n_x_curl_v(dim), n_x_u(dim), n_x_v(dim), n_x_u_x_n(dim), n_x_v_x_n(dim);
-            normal.cross3D(curl_u,n_x_curl_u);
-            normal.cross3D(curl_v,n_x_curl_v);
-            normal.cross3D(u,n_x_u);
-            normal.cross3D(v,n_x_v);
+         for (int i = 0; i < group.elems.Size(); i++)
+         {
+            fes.GetElementVDofs(group.elems[i], vdofs);
+            A.AddSubMatrix(vdofs, vdofs, elmats(i));
+         }
+      }
+      return;
+   }
 
-            elmat.Elem(l,k) += factor_ * weights[i] * area * (n_x_curl_u * v);
-            elmat.Elem(l,k) += factor_ * theta_ * weights[i] * area * (u * n_x_curl_v);
-            elmat.Elem(l,k) += factor_ * Cw_/h * weights[i] * area * (n_x_u * n_x_v);
+   // Symmetric case: keep the face matrices packed and scatter each upper
+   // triangle entry to both (i,j) and (j,i).
+   std::vector<mfem::DenseSymmetricMatrix> elmats;
+   for (auto &entry : groups)
+   {
+      const FaceGroup &group = entry.second;
+      AssembleSymmetricGroup(fes, group.bdr_faces, group.elems, elmats);
 
-         } 
+      for (int i = 0; i < group.elems.Size(); i++)
+      {
+         fes.GetElementVDofs(group.elems[i], vdofs);
+         const mfem::DenseSymmetricMatrix &elmat = elmats[i];
+         for (int l = 0; l < vdofs.Size(); l++)
+         {
+            const int il = vdofs[l] >= 0 ? vdofs[l] : -1 - vdofs[l];
+            const double sl = vdofs[l] >= 0 ? 1. : -1.;
+            for (int k = l; k < vdofs.Size(); k++)
+            {
+               const int jk = vdofs[k] >= 0 ? vdofs[k] : -1 - vdofs[k];
+               const double a = sl * (vdofs[k] >= 0 ? 1. : -1.) * elmat(l,k);
+               A.Add(il, jk, a);
+               if (k != l) { A.Add(jk, il, a); }
+            }
+         }
+      }
    }
 }
 
@@ -156,3 +526,174 @@ void ND_NitscheLFIntegrator::AssembleRHSElementVect(
 
 
 }
+
+
+void ND_NitscheSeparableLF::AddMode(mfem::VectorCoefficient &f,
+                                    std::function<double(double)> a)
+{
+   modes_.push_back(&f);
+   amplitudes_.push_back(std::move(a));
+}
+
+void ND_NitscheSeparableLF::Assemble()
+{
+   mode_vectors_.clear();
+   mode_vectors_.reserve(modes_.size());
+   for (mfem::VectorCoefficient *f : modes_)
+   {
+      mfem::LinearForm lf(&fes_);
+      lf.AddBdrFaceIntegrator(new ND_NitscheLFIntegrator(theta_, Cw_, *f, factor_));
+      lf.Assemble();
+      mode_vectors_.emplace_back(lf);
+   }
+}
+
+void ND_NitscheSeparableLF::Eval(double t, mfem::Vector &b) const
+{
+   MFEM_VERIFY(mode_vectors_.size() == modes_.size(),
+               "ND_NitscheSeparableLF::Eval(): Assemble() must be called first");
+
+   b.SetSize(fes_.GetVSize());
+   b = 0.;
+   for (size_t i = 0; i < mode_vectors_.size(); ++i)
+   {
+      b.Add(amplitudes_[i](t), mode_vectors_[i]);
+   }
+}
+
+mfem::Array<int> ND_NitscheMultigrid::NoEssentialBoundary(
+    const mfem::FiniteElementSpaceHierarchy &fespaces)
+{
+   const mfem::Array<int> &bdr_attributes =
+      fespaces.GetFESpaceAtLevel(0).GetMesh()->bdr_attributes;
+   mfem::Array<int> ess_bdr(bdr_attributes.Size() ? bdr_attributes.Max() : 0);
+   ess_bdr = 0;
+   return ess_bdr;
+}
+
+ND_NitscheMultigrid::ND_NitscheMultigrid(
+    mfem::FiniteElementSpaceHierarchy &fespaces, double theta, double Cw,
+    mfem::Coefficient *alpha, mfem::Coefficient *beta, double factor)
+   : mfem::GeometricMultigrid(fespaces, NoEssentialBoundary(fespaces)),
+     nitsche_(theta, Cw, factor)
+{
+   if (alpha) { curlcurl_.reset(new mfem::CurlCurlIntegrator(*alpha)); }
+   if (beta) { mass_.reset(new mfem::VectorFEMassIntegrator(*beta)); }
+
+   ConstructCoarseOperatorAndSolver(fespaces.GetFESpaceAtLevel(0));
+
+   for (int level = 1; level < fespaces.GetNumLevels(); ++level)
+   {
+      ConstructOperatorAndSmoother(fespaces.GetFESpaceAtLevel(level));
+   }
+}
+
+void ND_NitscheMultigrid::ConstructBilinearForm(mfem::FiniteElementSpace &fespace)
+{
+   // The integrators are owned by this object and shared by all levels.
+   mfem::BilinearForm *form = new mfem::BilinearForm(&fespace);
+   form->UseExternalIntegrators();
+   if (curlcurl_) { form->AddDomainIntegrator(curlcurl_.get()); }
+   if (mass_) { form->AddDomainIntegrator(mass_.get()); }
+   form->AddBdrFaceIntegrator(&nitsche_);
+   form->Assemble();
+   form->Finalize();
+
+   bfs.Append(form);
+}
+
+void ND_NitscheMultigrid::ConstructCoarseOperatorAndSolver(
+    mfem::FiniteElementSpace &coarse_fespace)
+{
+   ConstructBilinearForm(coarse_fespace);
+
+   mfem::SparseMatrix &A = bfs.Last()->SpMat();
+
+   // The coarse solve has to be accurate: an inexact inner Krylov solve would
+   // make the multigrid preconditioner nonlinear.
+#ifdef MFEM_USE_SUITESPARSE
+   AddLevel(&A, new mfem::UMFPackSolver(A), false, true);
+#else
+   mfem::GSSmoother *prec = new mfem::GSSmoother(A);
+
+   mfem::IterativeSolver *solver;
+   if (nitsche_.IsSymmetric()) { solver = new mfem::CGSolver(); }
+   else { solver = new mfem::GMRESSolver(); }
+   solver->SetPrintLevel(-1);
+   solver->SetMaxIter(std::max(1000, A.Height()));
+   solver->SetRelTol(1e-12);
+   solver->SetAbsTol(0.0);
+   solver->SetOperator(A);
+   solver->SetPreconditioner(*prec);
+
+   // The matrix is owned by the bilinear form and the solver does not own
+   // its preconditioner.
+   coarse_prec_.reset(prec);
+   AddLevel(&A, solver, false, true);
+#endif
+}
+
+const mfem::SparseMatrix &ND_NitscheMultigrid::ConstructGradient(
+    mfem::FiniteElementSpace &fespace)
+{
+   mfem::Mesh *mesh = fespace.GetMesh();
+   const int order = fespace.FEColl()->GetOrder();
+
+   h1_fecs_.emplace_back(new mfem::H1_FECollection(order, mesh->Dimension()));
+   h1_spaces_.emplace_back(new mfem::FiniteElementSpace(mesh, h1_fecs_.back().get()));
+
+   mfem::DiscreteLinearOperator *grad =
+      new mfem::DiscreteLinearOperator(h1_spaces_.back().get(), &fespace);
+   grad->AddDomainInterpolator(new mfem::GradientInterpolator);
+   grad->Assemble();
+   grad->Finalize();
+   gradients_.emplace_back(grad);
+
+   return grad->SpMat();
+}
+
+void ND_NitscheMultigrid::ConstructOperatorAndSmoother(mfem::FiniteElementSpace &fespace)
+{
+   ConstructBilinearForm(fespace);
+
+   mfem::SparseMatrix &A = bfs.Last()->SpMat();
+   if (!mass_)
+   {
+      AddLevel(&A, new mfem::GSSmoother(A), false, true);
+      return;
+   }
+   AddLevel(&A, new ND_HiptmairSmoother(A, ConstructGradient(fespace)), false, true);
+}
+
+
+ND_HiptmairSmoother::ND_HiptmairSmoother(const mfem::SparseMatrix &A,
+                                         const mfem::SparseMatrix &G)
+   : mfem::Solver(A.Height()), A_(A), G_(G), A_G_(mfem::RAP(A, G)),
+     r_(A.Height()), r_G_(G.Width()), x_G_(G.Width())
+{
+   MFEM_VERIFY(G.Height() == A.Height(),
+               "ND_HiptmairSmoother: incompatible discrete gradient");
+}
+
+void ND_HiptmairSmoother::SetOperator(const mfem::Operator &op)
+{
+   MFEM_ABORT("ND_HiptmairSmoother::SetOperator(): the operator is fixed at construction");
+}
+
+void ND_HiptmairSmoother::Mult(const mfem::Vector &b, mfem::Vector &x) const
+{
+   if (!iterative_mode) { x = 0.; }
+
+   A_.Gauss_Seidel_forw(b, x);
+
+   // Correction in the H1 potential space: r_G = G^T (b - A x).
+   A_.Mult(x, r_);
+   subtract(b, r_, r_);
+   G_.MultTranspose(r_, r_G_);
+   x_G_ = 0.;
+   A_G_->Gauss_Seidel_forw(r_G_, x_G_);
+   A_G_->Gauss_Seidel_back(r_G_, x_G_);
+   G_.AddMult(x_G_, x);
+
+   A_.Gauss_Seidel_back(b, x);
+}
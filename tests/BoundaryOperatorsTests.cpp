@@ -3,9 +3,11 @@
 #include "BoundaryOperators.h"
 #include "mfem.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <vector>
 
 TEST(ND_NitscheIntegratorTest, ThirdOrderExactIntegral)
@@ -525,3 +527,546 @@ TEST(ND_NitscheIntegratorTest, RotationVanishingTest)
       ASSERT_NEAR(0.0, Au(i), 1e-13);
    }
 }
+
+TEST(ND_NitscheIntegratorTest, SymmetricModeTest)
+{
+   // For theta=1 the face matrices are assembled in packed symmetric form.
+   // Checks that the assembled matrix is exactly symmetric and matches the
+   // (non-symmetric) theta=0 operator entrywise, with and without penalty.
+   const int refinements = 1;
+   const int order = 2;
+
+   mfem::Mesh mesh("../extern/mfem/data/ref-cube.mesh", 1, 1);
+   for (int l = 0; l < refinements; ++l) { mesh.UniformRefinement(); }
+   const int dim = mesh.Dimension();
+
+   auto u_func = [](const mfem::Vector &x, double, mfem::Vector &y)
+   {
+      const double X = x(0), Y = x(1), Z = x(2);
+      y.SetSize(3);
+      y(0) = X * Y * Z;
+      y(1) = X * X * Z;
+      y(2) = X * Y * Y;
+   };
+   auto v_func = [](const mfem::Vector &x, double, mfem::Vector &y)
+   {
+      const double X = x(0), Y = x(1), Z = x(2);
+      y.SetSize(3);
+      y(0) = X * X + Y;
+      y(1) = Y * Y + Z;
+      y(2) = Z * Z + X;
+   };
+
+   mfem::VectorFunctionCoefficient u_coef(3, u_func);
+   mfem::VectorFunctionCoefficient v_coef(3, v_func);
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   mfem::GridFunction u(&nd), v(&nd);
+   u.ProjectCoefficient(u_coef);
+   v.ProjectCoefficient(v_coef);
+
+   ASSERT_TRUE(ND_NitscheIntegrator(1.0, 0.0).IsSymmetric());
+   ASSERT_FALSE(ND_NitscheIntegrator(-1.0, 0.0).IsSymmetric());
+
+   // Without penalty A1 = A0 + A0^T. With penalty P = A0(Cw) - A0(0) is
+   // symmetric, so A1(Cw) = A0(Cw) + A0(Cw)^T - P = A0(Cw)^T + A0(0).
+   mfem::BilinearForm A00(&nd);
+   A00.AddBdrFaceIntegrator(new ND_NitscheIntegrator(0.0, 0.0));
+   A00.Assemble();
+   A00.Finalize();
+
+   for (double Cw : {0.0, 10.0})
+   {
+      mfem::BilinearForm A0(&nd), A1(&nd);
+      A0.AddBdrFaceIntegrator(new ND_NitscheIntegrator(0.0, Cw));
+      A1.AddBdrFaceIntegrator(new ND_NitscheIntegrator(1.0, Cw));
+      A0.Assemble();
+      A1.Assemble();
+      A0.Finalize();
+      A1.Finalize();
+
+      ASSERT_EQ(0.0, A1.SpMat().IsSymmetric()) << "Cw=" << Cw << "\n";
+
+      std::unique_ptr<mfem::SparseMatrix> A0T(mfem::Transpose(A0.SpMat()));
+      std::unique_ptr<mfem::SparseMatrix> D1(mfem::Add(1.0, A1.SpMat(), -1.0, *A0T));
+      std::unique_ptr<mfem::SparseMatrix> D(mfem::Add(1.0, *D1, -1.0, A00.SpMat()));
+      ASSERT_NEAR(0.0, D->MaxNorm(), 1e-10) << "Cw=" << Cw << "\n";
+
+      mfem::Vector A0v(A0.Height()), A00u(A00.Height()), A1u(A1.Height());
+      A0.Mult(v, A0v);
+      A00.Mult(u, A00u);
+      A1.Mult(u, A1u);
+
+      ASSERT_NEAR(u * A0v + v * A00u, v * A1u, 1e-10) << "Cw=" << Cw << "\n";
+   }
+}
+
+TEST(ND_NitscheIntegratorTest, PackedSymmetricFaceMatrix)
+{
+   // Calls AssembleSymmetricFaceMatrix directly on boundary faces (order 2,
+   // Cw > 0) and checks every stored entry k >= l against AssembleFaceMatrix,
+   // and against the full-loop theta=0 path: with P the penalty-only matrix,
+   // E1(l,k) = E0(l,k) + E0(k,l) - P(l,k) = E0(k,l) + E00(l,k).
+   mfem::Mesh mesh("../tests/mesh/LidDrivenCavity3D.msh");
+   const int dim = mesh.Dimension();
+   const int order = 2;
+   const double Cw = 10.0;
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   ND_NitscheIntegrator integ1(1.0, Cw), integ0(0.0, Cw), integ00(0.0, 0.0);
+   mfem::DenseSymmetricMatrix packed;
+   mfem::DenseMatrix E1, E0, E00;
+
+   for (int i = 0; i < mesh.GetNBE(); i += 97)
+   {
+      mfem::FaceElementTransformations *Trans = mesh.GetBdrFaceTransformations(i);
+      const mfem::FiniteElement &el = *nd.GetFE(Trans->Elem1No);
+
+      integ1.AssembleSymmetricFaceMatrix(el, *Trans, packed);
+      integ1.AssembleFaceMatrix(el, el, *Trans, E1);
+      integ0.AssembleFaceMatrix(el, el, *Trans, E0);
+      integ00.AssembleFaceMatrix(el, el, *Trans, E00);
+
+      ASSERT_EQ(el.GetDof(), packed.Height());
+      for (int l = 0; l < el.GetDof(); ++l)
+         for (int k = l; k < el.GetDof(); ++k)
+         {
+            ASSERT_EQ(E1(l,k), packed(l,k)) << "face=" << i << "\n";
+            ASSERT_NEAR(E0(k,l) + E00(l,k), packed(l,k), 1e-10)
+               << "face=" << i << " l=" << l << " k=" << k << "\n";
+         }
+   }
+}
+
+TEST(ND_NitscheMultigridTest, HierarchyTest)
+{
+   // Solves curl-curl + mass + Nitsche (theta=1, Cw=10) with CG preconditioned
+   // by ND_NitscheMultigrid on a hierarchy with two uniform refinements
+   // followed by an order-refined level (p=1 -> p=2), so the V-cycle goes
+   // through both h- and p-prolongations. Checks convergence and that the
+   // discrete solution is recovered.
+   const int refinements = 2;
+   const int order = 1;
+
+   mfem::Mesh mesh("../extern/mfem/data/ref-cube.mesh", 1, 1);
+   const int dim = mesh.Dimension();
+
+   auto u_func = [](const mfem::Vector &x, double, mfem::Vector &y)
+   {
+      const double X = x(0), Y = x(1), Z = x(2);
+      y.SetSize(3);
+      y(0) = std::sin(M_PI * Y) * Z;
+      y(1) = X * X * Z;
+      y(2) = std::exp(X) * Y;
+   };
+   mfem::VectorFunctionCoefficient u_coef(3, u_func);
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   auto fec_p = std::make_unique<mfem::ND_FECollection>(order + 1, dim);
+   mfem::FiniteElementSpace coarse_nd(&mesh, fec.get());
+   mfem::FiniteElementSpaceHierarchy fespaces(&mesh, &coarse_nd, false, false);
+   for (int l = 0; l < refinements; ++l) { fespaces.AddUniformlyRefinedLevel(); }
+   fespaces.AddOrderRefinedLevel(fec_p.get());
+   ASSERT_EQ(refinements + 2, fespaces.GetNumLevels());
+
+   mfem::ConstantCoefficient one(1.0);
+   ND_NitscheMultigrid mg(fespaces, 1.0, 10.0, &one, &one);
+
+   mfem::GridFunction u(&fespaces.GetFinestFESpace());
+   u.ProjectCoefficient(u_coef);
+
+   mfem::BilinearForm &A = mg.GetFormAtLevel(fespaces.GetNumLevels() - 1);
+   mfem::Vector b(A.Height()), x(A.Height());
+   A.Mult(u, b);
+   x = 0.0;
+
+   mfem::CGSolver cg;
+   cg.SetPrintLevel(-1);
+   cg.SetMaxIter(100);
+   cg.SetRelTol(1e-10);
+   cg.SetAbsTol(0.0);
+   cg.SetOperator(A.SpMat());
+   cg.SetPreconditioner(mg);
+   cg.Mult(b, x);
+
+   std::cout << "h+p hierarchy, dofs: " << A.Height()
+             << ", CG iterations: " << cg.GetNumIterations() << '\n';
+
+   ASSERT_TRUE(cg.GetConverged());
+   x -= u;
+   ASSERT_NEAR(0.0, x.Normlinf(), 1e-6);
+}
+
+TEST(ND_NitscheMultigridTest, MeshIndependenceTest)
+{
+   // Solves curl-curl + mass + Nitsche (theta=1, Cw=10) with CG preconditioned
+   // by ND_NitscheMultigrid for 1, 2 and 3 refinements. The iteration counts
+   // must stay bounded under refinement, and the solution must be recovered.
+   const int order = 1;
+   std::vector<int> iterations;
+
+   auto u_func = [](const mfem::Vector &x, double, mfem::Vector &y)
+   {
+      const double X = x(0), Y = x(1), Z = x(2);
+      y.SetSize(3);
+      y(0) = std::sin(M_PI * Y) * Z;
+      y(1) = X * X * Z;
+      y(2) = std::exp(X) * Y;
+   };
+   mfem::VectorFunctionCoefficient u_coef(3, u_func);
+   mfem::ConstantCoefficient one(1.0);
+
+   for (int refinements = 1; refinements < 4; ++refinements)
+   {
+      mfem::Mesh mesh("../extern/mfem/data/ref-cube.mesh", 1, 1);
+      const int dim = mesh.Dimension();
+
+      auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+      mfem::FiniteElementSpace coarse_nd(&mesh, fec.get());
+      mfem::FiniteElementSpaceHierarchy fespaces(&mesh, &coarse_nd, false, false);
+      for (int l = 0; l < refinements; ++l) { fespaces.AddUniformlyRefinedLevel(); }
+
+      ND_NitscheMultigrid mg(fespaces, 1.0, 10.0, &one, &one);
+
+      mfem::GridFunction u(&fespaces.GetFinestFESpace());
+      u.ProjectCoefficient(u_coef);
+
+      mfem::BilinearForm &A = mg.GetFormAtLevel(fespaces.GetNumLevels() - 1);
+      mfem::Vector b(A.Height()), x(A.Height());
+      A.Mult(u, b);
+      x = 0.0;
+
+      mfem::CGSolver cg;
+      cg.SetPrintLevel(-1);
+      cg.SetMaxIter(500);
+      cg.SetRelTol(1e-10);
+      cg.SetAbsTol(0.0);
+      cg.SetOperator(A.SpMat());
+      cg.SetPreconditioner(mg);
+      cg.Mult(b, x);
+
+      ASSERT_TRUE(cg.GetConverged()) << "refinements=" << refinements << "\n";
+      x -= u;
+      ASSERT_NEAR(0.0, x.Normlinf(), 1e-6);
+
+      iterations.push_back(cg.GetNumIterations());
+      std::cout << "refinements: " << refinements
+                << ", dofs: " << A.Height()
+                << ", CG iterations: " << iterations.back() << '\n';
+   }
+
+   for (size_t i = 1; i < iterations.size(); ++i)
+   {
+      // Point Gauss-Seidel alone roughly doubles the count per refinement.
+      EXPECT_LE(iterations[i], iterations[0] + 2)
+         << "refinements=" << i + 1 << "\n";
+   }
+}
+
+TEST(ND_NitscheSeparableLFTest, MatchesFullSweep)
+{
+   // Time-separable data g(x,t) = cos(t) f1(x) + t^2 f2(x).
+   // Checks the cached combination against a full ND_NitscheLFIntegrator
+   // sweep with a time-dependent coefficient at several times.
+   const int refinements = 1;
+   const int order = 2;
+   const double theta = -1.0, Cw = 10.0;
+
+   mfem::Mesh mesh("../extern/mfem/data/ref-cube.mesh", 1, 1);
+   for (int l = 0; l < refinements; ++l) { mesh.UniformRefinement(); }
+   const int dim = mesh.Dimension();
+
+   auto f1_func = [](const mfem::Vector &x, mfem::Vector &y)
+   {
+      y.SetSize(3);
+      y(0) = -x(1);
+      y(1) =  x(0);
+      y(2) =  1.0;
+   };
+   auto f2_func = [](const mfem::Vector &x, mfem::Vector &y)
+   {
+      y.SetSize(3);
+      y(0) = std::sin(M_PI * x(2));
+      y(1) = x(0) * x(1);
+      y(2) = std::exp(x(1));
+   };
+   auto g_func = [&](const mfem::Vector &x, double t, mfem::Vector &y)
+   {
+      mfem::Vector y1(3), y2(3);
+      f1_func(x, y1);
+      f2_func(x, y2);
+      y.SetSize(3);
+      add(std::cos(t), y1, t * t, y2, y);
+   };
+
+   mfem::VectorFunctionCoefficient f1_coef(3, f1_func);
+   mfem::VectorFunctionCoefficient f2_coef(3, f2_func);
+   mfem::VectorFunctionCoefficient g_coef(3, g_func);
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   ND_NitscheSeparableLF g_sep(nd, theta, Cw);
+   g_sep.AddMode(f1_coef, [](double t) { return std::cos(t); });
+   g_sep.AddMode(f2_coef, [](double t) { return t * t; });
+   g_sep.Assemble();
+   ASSERT_EQ(2, g_sep.GetNumModes());
+
+   for (double t : {0.0, 0.3, 1.7})
+   {
+      g_coef.SetTime(t);
+      mfem::LinearForm f(&nd);
+      f.AddBdrFaceIntegrator(new ND_NitscheLFIntegrator(theta, Cw, g_coef));
+      f.Assemble();
+
+      mfem::Vector b;
+      g_sep.Eval(t, b);
+      ASSERT_EQ(f.Size(), b.Size());
+
+      for (int i = 0; i < b.Size(); ++i)
+      {
+         ASSERT_NEAR(f(i), b(i), 1e-10) << "t=" << t << "\n";
+      }
+   }
+}
+
+TEST(ND_NitscheFaceBatchTest, MatchesFaceIntegrator)
+{
+   // Batched cross-face assembly must reproduce the per-face
+   // ND_NitscheIntegrator entrywise, for symmetric and non-symmetric theta
+   // and p = 1, 2. The mesh has 1406 boundary faces, not a multiple of
+   // ND_NitscheFaceBatch::lanes, so the last batch has zero-weight lanes.
+   mfem::Mesh mesh("../tests/mesh/LidDrivenCavity3D.msh");
+   const int dim = mesh.Dimension();
+   ASSERT_NE(0, mesh.GetNBE() % ND_NitscheFaceBatch::lanes);
+
+   for (int order = 1; order < 3; ++order)
+   {
+      auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+      mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+      for (double theta : {-1.0, 1.0})
+      {
+         mfem::BilinearForm A(&nd);
+         A.AddBdrFaceIntegrator(new ND_NitscheIntegrator(theta, 10.0));
+         A.Assemble();
+         A.Finalize();
+
+         mfem::SparseMatrix B(nd.GetVSize());
+         ND_NitscheFaceBatch(theta, 10.0).Assemble(nd, B);
+         B.Finalize();
+
+         std::unique_ptr<mfem::SparseMatrix> D(mfem::Add(1.0, B, -1.0, A.SpMat()));
+         ASSERT_NEAR(0.0, D->MaxNorm(), 1e-10)
+            << "order=" << order << " theta=" << theta << "\n";
+      }
+   }
+}
+
+TEST(ND_NitscheFaceBatchTest, PartialBatch)
+{
+   // Face matrices of a partial batch (lanes + 3 faces) must match the
+   // per-face integrator entrywise, including the faces in the tail lanes.
+   mfem::Mesh mesh("../tests/mesh/LidDrivenCavity3D.msh");
+   const int dim = mesh.Dimension();
+   const int order = 1;
+   const double theta = -1.0, Cw = 10.0;
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   const int nfaces = ND_NitscheFaceBatch::lanes + 3;
+   mfem::Array<int> bdr_faces(nfaces);
+   for (int i = 0; i < nfaces; ++i) { bdr_faces[i] = 2 * i + 1; }
+
+   mfem::DenseTensor elmats;
+   ND_NitscheFaceBatch(theta, Cw).AssembleFaceMatrices(nd, bdr_faces, elmats);
+   ASSERT_EQ(nfaces, elmats.SizeK());
+
+   ND_NitscheIntegrator integ(theta, Cw);
+   mfem::DenseMatrix elmat;
+   for (int i = 0; i < nfaces; ++i)
+   {
+      mfem::FaceElementTransformations *Trans =
+         mesh.GetBdrFaceTransformations(bdr_faces[i]);
+      const mfem::FiniteElement &el = *nd.GetFE(Trans->Elem1No);
+      integ.AssembleFaceMatrix(el, el, *Trans, elmat);
+
+      ASSERT_EQ(elmat.Height(), elmats(i).Height());
+      for (int l = 0; l < elmat.Height(); ++l)
+         for (int k = 0; k < elmat.Width(); ++k)
+         {
+            ASSERT_NEAR(elmat(l,k), elmats(i)(l,k), 1e-10)
+               << "face=" << bdr_faces[i] << " l=" << l << " k=" << k << "\n";
+         }
+   }
+}
+
+TEST(ND_NitscheFaceBatchTest, PackedPartialBatch)
+{
+   // For theta=1 the packed face matrices of a partial batch (lanes + 3
+   // faces) must match ND_NitscheIntegrator::AssembleSymmetricFaceMatrix.
+   mfem::Mesh mesh("../tests/mesh/LidDrivenCavity3D.msh");
+   const int dim = mesh.Dimension();
+   const int order = 2;
+   const double Cw = 10.0;
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   const int nfaces = ND_NitscheFaceBatch::lanes + 3;
+   mfem::Array<int> bdr_faces(nfaces);
+   for (int i = 0; i < nfaces; ++i) { bdr_faces[i] = 3 * i + 2; }
+
+   std::vector<mfem::DenseSymmetricMatrix> elmats;
+   ND_NitscheFaceBatch(1.0, Cw).AssembleSymmetricFaceMatrices(nd, bdr_faces, elmats);
+   ASSERT_EQ(nfaces, static_cast<int>(elmats.size()));
+
+   ND_NitscheIntegrator integ(1.0, Cw);
+   mfem::DenseSymmetricMatrix elmat;
+   for (int i = 0; i < nfaces; ++i)
+   {
+      mfem::FaceElementTransformations *Trans =
+         mesh.GetBdrFaceTransformations(bdr_faces[i]);
+      const mfem::FiniteElement &el = *nd.GetFE(Trans->Elem1No);
+      integ.AssembleSymmetricFaceMatrix(el, *Trans, elmat);
+
+      ASSERT_EQ(elmat.Height(), elmats[i].Height());
+      for (int l = 0; l < elmat.Height(); ++l)
+         for (int k = l; k < elmat.Height(); ++k)
+         {
+            ASSERT_NEAR(elmat(l,k), elmats[i](l,k), 1e-10)
+               << "face=" << bdr_faces[i] << " l=" << l << " k=" << k << "\n";
+         }
+   }
+}
+
+namespace
+{
+
+// Two unit hexes side by side with a boundary element on the shared face
+// x = 1 (attribute 2), as produced by an internal physical surface.
+const char *two_hex_mesh =
+   "MFEM mesh v1.0\n"
+   "dimension\n3\n"
+   "elements\n2\n"
+   "1 5 0 1 4 3 6 7 10 9\n"
+   "1 5 1 2 5 4 7 8 11 10\n"
+   "boundary\n11\n"
+   "1 3 0 3 4 1\n"
+   "1 3 1 4 5 2\n"
+   "1 3 6 7 10 9\n"
+   "1 3 7 8 11 10\n"
+   "1 3 0 1 7 6\n"
+   "1 3 1 2 8 7\n"
+   "1 3 3 9 10 4\n"
+   "1 3 4 10 11 5\n"
+   "1 3 0 6 9 3\n"
+   "1 3 2 5 11 8\n"
+   "2 3 1 4 10 7\n"
+   "vertices\n12\n3\n"
+   "0 0 0\n1 0 0\n2 0 0\n0 1 0\n1 1 0\n2 1 0\n"
+   "0 0 1\n1 0 1\n2 0 1\n0 1 1\n1 1 1\n2 1 1\n";
+
+}
+
+TEST(ND_NitscheFaceBatchTest, SkipsInteriorBoundaryFaces)
+{
+   // Assemble() must skip the boundary element on the interior face exactly
+   // like BilinearForm does.
+   std::istringstream input(two_hex_mesh);
+   mfem::Mesh mesh(input, 1, 1);
+   const int dim = mesh.Dimension();
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(1, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   for (double theta : {-1.0, 1.0})
+   {
+      mfem::BilinearForm A(&nd);
+      A.AddBdrFaceIntegrator(new ND_NitscheIntegrator(theta, 10.0));
+      A.Assemble();
+      A.Finalize();
+
+      mfem::SparseMatrix B(nd.GetVSize());
+      ND_NitscheFaceBatch(theta, 10.0).Assemble(nd, B);
+      B.Finalize();
+
+      std::unique_ptr<mfem::SparseMatrix> D(mfem::Add(1.0, B, -1.0, A.SpMat()));
+      ASSERT_NEAR(0.0, D->MaxNorm(), 1e-10) << "theta=" << theta << "\n";
+   }
+}
+
+TEST(ND_NitscheFaceBatchDeathTest, RejectsInteriorBoundaryFace)
+{
+   // Passing the interior boundary element to AssembleFaceMatrices directly
+   // must fail with an error instead of dereferencing a null transformation.
+   std::istringstream input(two_hex_mesh);
+   mfem::Mesh mesh(input, 1, 1);
+   const int dim = mesh.Dimension();
+
+   auto fec = std::make_unique<mfem::ND_FECollection>(1, dim);
+   mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+   mfem::Array<int> bdr_faces(2);
+   bdr_faces[0] = 0;
+   bdr_faces[1] = 10;
+   mfem::DenseTensor elmats;
+   ND_NitscheFaceBatch batch(-1.0, 10.0);
+   EXPECT_DEATH(batch.AssembleFaceMatrices(nd, bdr_faces, elmats),
+                "interior or nonconforming face");
+}
+
+TEST(ND_NitscheFaceBatchTest, TimingAgainstFaceIntegrator)
+{
+   // Times ND_NitscheFaceBatch::Assemble against BilinearForm with
+   // ND_NitscheIntegrator on LidDrivenCavity3D.msh for p = 1, 2 and
+   // theta = -1, 1 (best of several repetitions). Reports the timings only;
+   // correctness is covered by MatchesFaceIntegrator.
+   const int repetitions = 5;
+
+   mfem::Mesh mesh("../tests/mesh/LidDrivenCavity3D.msh");
+   const int dim = mesh.Dimension();
+
+   for (int order = 1; order < 3; ++order)
+   {
+      auto fec = std::make_unique<mfem::ND_FECollection>(order, dim);
+      mfem::FiniteElementSpace nd(&mesh, fec.get());
+
+      for (double theta : {-1.0, 1.0})
+      {
+         double t_face = 1e300, t_batch = 1e300;
+         mfem::StopWatch sw;
+
+         for (int r = 0; r < repetitions; ++r)
+         {
+            mfem::BilinearForm A(&nd);
+            A.AddBdrFaceIntegrator(new ND_NitscheIntegrator(theta, 10.0));
+            sw.Clear();
+            sw.Start();
+            A.Assemble();
+            sw.Stop();
+            t_face = std::min(t_face, sw.RealTime());
+
+            mfem::SparseMatrix B(nd.GetVSize());
+            ND_NitscheFaceBatch batch(theta, 10.0);
+            sw.Clear();
+            sw.Start();
+            batch.Assemble(nd, B);
+            sw.Stop();
+            t_batch = std::min(t_batch, sw.RealTime());
+         }
+
+         std::cout << "order: " << order << ", theta: " << theta
+                   << ", ND_NitscheIntegrator: " << t_face << " s"
+                   << ", ND_NitscheFaceBatch: " << t_batch << " s"
+                   << ", speedup: " << t_face / t_batch << '\n';
+
+         EXPECT_GT(t_batch, 0.0);
+      }
+   }
+}